@@ -1,5 +1,7 @@
 'use strict';
 var path = require('path');
+var util = require('util');
+var EventEmitter = require('events').EventEmitter;
 
 
 var IS_LINUX = require('os').platform() === 'linux'
@@ -147,6 +149,277 @@ if (IS_LINUX) {
     module.exports.swapoff = posix.swapoff
 }
 
+var CGROUP_ROOT = '/sys/fs/cgroup';
+var PROC_SELF_CGROUP = '/proc/self/cgroup';
+
+// cgroup v2 file values: a non-negative integer, Infinity or null for "max",
+// an array of those for multi-value files such as cpu.max, or a string
+// written as is
+function cgroup_value(value, nested) {
+    if (value === null || value === Infinity) {
+        return 'max';
+    }
+    if (typeof value === 'number' && value >= 0 &&
+            value <= Number.MAX_SAFE_INTEGER && Math.floor(value) === value) {
+        return String(value);
+    }
+    if (typeof value === 'string' && !nested) {
+        return value;
+    }
+    if (Array.isArray(value) && !nested) {
+        return value.map(function (item) {
+            return cgroup_value(item, true);
+        }).join(' ');
+    }
+    throw new TypeError("invalid cgroup value: " + value);
+}
+
+// cgroup directory of this process, looked up on first use
+var self_cgroup = null;
+
+function cgroup_file(dir, file) {
+    if (!dir) {
+        self_cgroup = self_cgroup || module.exports.cgroup_path();
+        dir = self_cgroup;
+    }
+    return path.join(dir, file);
+}
+
+// Call fn(name) for a file in a cgroup directory. If the cgroup of this
+// process was used and the call fails, e.g. because the process was moved
+// and its old cgroup removed, the cgroup is looked up again next time.
+function cgroup_call(dir, file, fn) {
+    var name = cgroup_file(dir, file);
+    if (dir) {
+        return fn(name);
+    }
+    try {
+        return fn(name);
+    } catch (err) {
+        self_cgroup = null;
+        throw err;
+    }
+}
+
+if ('cgroup_path' in posix) {
+    // cgroup v2 is Linux-only; `root` and `proc_cgroup` can point to a
+    // different cgroupfs mount or a fake tree. Only the default root is
+    // checked to be a cgroup2 mount, falling back to its "unified" subdir.
+    module.exports.cgroup_path = function (root, proc_cgroup) {
+        return posix.cgroup_path(root || CGROUP_ROOT,
+                                 proc_cgroup || PROC_SELF_CGROUP, !root);
+    };
+
+    // read all values of a cgroup file into a Float64Array, reusing `array`
+    // when given and large enough
+    module.exports.cgroup_read = function (file, dir, array) {
+        return cgroup_call(dir, file, function (name) {
+            var count;
+            array = array || new Float64Array(8);
+            count = posix.cgroup_read(name, array);
+            if (count > array.length) {
+                array = new Float64Array(count);
+                count = posix.cgroup_read(name, array);
+            }
+            return array.subarray(0, count);
+        });
+    };
+
+    // decode a cgroup file into a number, an array or a keyed object
+    module.exports.cgroup_stat = function (file, dir) {
+        return cgroup_call(dir, file, posix.cgroup_stat);
+    };
+
+    module.exports.cgroup_write = function (file, value, dir) {
+        return cgroup_call(dir, file, function (name) {
+            return posix.cgroup_write(name, cgroup_value(value));
+        });
+    };
+
+    // close cached fds and forget the cgroup of this process, e.g. after
+    // it has been moved to another cgroup
+    module.exports.cgroup_close = function () {
+        self_cgroup = null;
+        return posix.cgroup_close();
+    };
+}
+
+var PROC_PRESSURE = '/proc/pressure';
+var PSI_RESOURCES = { cpu: true, memory: true, io: true, irq: true };
+
+// Call fn(name) for a pressure file. `resource` is 'cpu', 'memory', 'io' or
+// 'irq', or an absolute path to a pressure file. `dir` selects the
+// <resource>.pressure file of a cgroup instead of the system-wide one, `true`
+// meaning the cgroup of this process.
+function psi_call(resource, dir, fn) {
+    if (resource.charAt(0) === '/') {
+        return fn(resource);
+    }
+    if (!PSI_RESOURCES[resource]) {
+        throw new Error("invalid pressure resource: " + resource);
+    }
+    if (dir) {
+        return cgroup_call(dir === true ? null : dir, resource + '.pressure', fn);
+    }
+    return fn(path.join(PROC_PRESSURE, resource));
+}
+
+// "full" is null when the kernel does not report it for the resource
+function psi_decode(values) {
+    return {
+        some: { avg10: values[0], avg60: values[1], avg300: values[2],
+                total: values[3] },
+        full: isNaN(values[4]) ? null :
+            { avg10: values[4], avg60: values[5], avg300: values[6],
+              total: values[7] }
+    };
+}
+
+// trigger strings are "<some|full> <threshold us> <window us>"; objects are
+// checked here, the kernel only reports EINVAL
+function psi_trigger(trigger) {
+    var stall, key;
+    if (typeof trigger === 'string') {
+        return trigger;
+    }
+    if (!trigger || typeof trigger !== 'object') {
+        throw new Error("invalid pressure trigger: " + trigger);
+    }
+    stall = trigger.stall === undefined ? 'some' : trigger.stall;
+    if (stall !== 'some' && stall !== 'full') {
+        throw new Error("invalid pressure trigger stall: " + stall);
+    }
+    for (key in { threshold: true, window: true }) {
+        if (typeof trigger[key] !== 'number' || !(trigger[key] > 0) ||
+                Math.floor(trigger[key]) !== trigger[key]) {
+            throw new Error("invalid pressure trigger " + key + ": " + trigger[key]);
+        }
+    }
+    return [stall, trigger.threshold, trigger.window].join(' ');
+}
+
+// Emits 'pressure' with the decoded values and the raw Float64Array every
+// time the trigger fires, and 'error' if the trigger goes away.
+function PressureWatcher(file, trigger) {
+    var self = this;
+    EventEmitter.call(this);
+    this.path = file;
+    this.trigger = psi_trigger(trigger);
+    this._id = posix.psi_watch(file, this.trigger, function (err, values) {
+        if (err) {
+            self.close();
+            self.emit('error', err);
+            return;
+        }
+        self.emit('pressure', psi_decode(values), values);
+    });
+}
+util.inherits(PressureWatcher, EventEmitter);
+
+PressureWatcher.prototype.close = function () {
+    if (this._id !== null) {
+        posix.psi_unwatch(this._id);
+        this._id = null;
+    }
+    return this;
+};
+
+PressureWatcher.prototype.ref = function () {
+    if (this._id !== null) {
+        posix.psi_ref(this._id, true);
+    }
+    return this;
+};
+
+PressureWatcher.prototype.unref = function () {
+    if (this._id !== null) {
+        posix.psi_ref(this._id, false);
+    }
+    return this;
+};
+
+if ('psi_read' in posix) {
+    // one-shot pressure sample: Float64Array [ some avg10, avg60, avg300,
+    // total, full avg10, avg60, avg300, total ], reusing `array` when given
+    module.exports.psi_read = function (resource, dir, array) {
+        array = array || new Float64Array(8);
+        psi_call(resource, dir, function (name) {
+            posix.psi_read(name, array);
+        });
+        return array;
+    };
+
+    module.exports.psi_stat = function (resource, dir) {
+        return psi_decode(module.exports.psi_read(resource, dir));
+    };
+}
+
+if ('psi_watch' in posix) {
+    module.exports.PressureWatcher = PressureWatcher;
+    module.exports.psi_watch = function (resource, trigger, dir) {
+        return psi_call(resource, dir, function (name) {
+            return new PressureWatcher(name, trigger);
+        });
+    };
+}
+
+// errno number -> name as in Node's own errors, e.g. 11 -> 'EAGAIN'
+function errno_name(errno) {
+    var name = util.getSystemErrorName(-errno);
+    return /^E/.test(name) ? name : errno;
+}
+
+// layout of the native counter snapshot, the bindings are registered once
+// when the extension is loaded
+var stats_layout = posix.stats_layout();
+var stats_data = new Float64Array(stats_layout.bindings.length * stats_layout.record_size);
+
+// Decode a native counter snapshot into
+// { binding: { calls, errors, total_ns, max_ns, errno, latency } }
+// Only bindings that have been called since the last reset are included.
+// `latency` is a Float64Array of bucket counts, bucket i covers latencies
+// starting from `stats.latency_floor_ns[i]` nanoseconds.
+function stats() {
+    var layout = stats_layout, rsize = layout.record_size, data = stats_data,
+        count = posix.stats_snapshot(data), result = {}, i, j, base, entry, n;
+    for (i = 0; i < count; ++i) {
+        base = i * rsize;
+        if (!data[base + layout.calls]) {
+            continue;
+        }
+        entry = {
+            calls: data[base + layout.calls],
+            errors: data[base + layout.errors],
+            total_ns: data[base + layout.total_ns],
+            max_ns: data[base + layout.max_ns],
+            errno: {},
+            // copied, the snapshot buffer is reused by the next call
+            latency: data.slice(base + layout.latency_offset,
+                                base + layout.latency_offset + layout.latency_count)
+        };
+        for (j = 0; j < layout.errno_count; ++j) {
+            n = data[base + layout.errno_offset + j];
+            if (n) {
+                entry.errno[j === 0 ? 'other' : errno_name(j)] = n;
+            }
+        }
+        result[layout.bindings[i]] = entry;
+    }
+    return result;
+}
+
+stats.latency_floor_ns = new Float64Array(stats_layout.latency_floor_ns);
+
+module.exports.stats = stats;
+module.exports.enable_stats = function (enable) {
+    return posix.stats_enable(enable === undefined ? true : !!enable);
+};
+module.exports.reset_stats = posix.stats_reset;
+
+if (process.env.NODE_POSIX_STATS) {
+    posix.stats_enable(true);
+}
+
 if ('initgroups' in posix) {
     // initgroups is in SVr4 and 4.3BSD, not POSIX
     module.exports.initgroups = function (user, group) {
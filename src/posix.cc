@@ -7,9 +7,17 @@
 #include <pwd.h> // getpwnam, passwd
 #include <grp.h> // getgrnam, group
 #include <syslog.h> // openlog, closelog, syslog, setlogmask
+#include <atomic>
 
 #ifdef __linux__
 #  include <sys/swap.h>  // swapon, swapoff
+#  include <fcntl.h>  // open
+#  include <sys/vfs.h>  // statfs
+#  include <math.h>  // INFINITY
+#  include <stdlib.h>  // strtod
+#  include <ctype.h>  // isdigit
+#  include <string>
+#  include <vector>
 #endif
 
 using v8::Array;
@@ -665,9 +673,971 @@ NAN_METHOD(node_update_swap_constants) {
 
     info.GetReturnValue().Set(Nan::Undefined());
 }
+
+// cgroup v2 interface files are small text files that the kernel regenerates
+// on every read from offset 0, so they are kept open and re-read with pread()
+// to avoid an open/close per sample.
+static const size_t MAX_CGROUP_FDS = 64;
+
+struct cgroup_fd_t {
+    std::string path;
+    int fd;
+};
+
+static cgroup_fd_t cgroup_fds[MAX_CGROUP_FDS];
+static size_t cgroup_fd_count = 0;
+
+// returns a cached read-only fd for path, or -1 with errno set
+static int cgroup_fd(const char* path) {
+    for (size_t i = 0; i < cgroup_fd_count; ++i) {
+        if (cgroup_fds[i].path == path) {
+            return cgroup_fds[i].fd;
+        }
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (cgroup_fd_count == MAX_CGROUP_FDS) {
+        // evict the oldest entry
+        close(cgroup_fds[0].fd);
+        for (size_t i = 1; i < MAX_CGROUP_FDS; ++i) {
+            cgroup_fds[i - 1] = cgroup_fds[i];
+        }
+        --cgroup_fd_count;
+    }
+
+    cgroup_fds[cgroup_fd_count].path = path;
+    cgroup_fds[cgroup_fd_count].fd = fd;
+    ++cgroup_fd_count;
+    return fd;
+}
+
+// read the whole file from offset 0, returns false with errno set
+static bool pread_all(int fd, std::string* out) {
+    char buf[4096];
+    out->clear();
+    for (;;) {
+        ssize_t n = pread(fd, buf, sizeof(buf), out->size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        out->append(buf, n);
+    }
+}
+
+// close and forget the cached fd of path, if any
+static void cgroup_fd_drop(const char* path) {
+    for (size_t i = 0; i < cgroup_fd_count; ++i) {
+        if (cgroup_fds[i].path == path) {
+            close(cgroup_fds[i].fd);
+            for (size_t j = i + 1; j < cgroup_fd_count; ++j) {
+                cgroup_fds[j - 1] = cgroup_fds[j];
+            }
+            --cgroup_fd_count;
+            cgroup_fds[cgroup_fd_count].path.clear();
+            return;
+        }
+    }
+}
+
+// read the whole file behind a cached fd, returns false with errno set
+static bool cgroup_pread(const char* path, std::string* out) {
+    int fd = cgroup_fd(path);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (!pread_all(fd, out)) {
+        // e.g. ENODEV after the cgroup was removed, the path may be
+        // recreated so open it again on the next read
+        int read_errno = errno;
+        cgroup_fd_drop(path);
+        errno = read_errno;
+        return false;
+    }
+
+    return true;
+}
+
+// Limit files (cpu.max, memory.high, pids.max, ...) may start a line with
+// the value "max". In keyed files (memory.events, pids.events, ...) a
+// leading "max" is a key instead, and "pids.events" ("max 0") cannot be told
+// apart from "cpu.max" ("max 100000") by its contents, so limit files are
+// listed by name.
+static const char* cgroup_limit_files[] = {
+    "cgroup.max.depth",
+    "cgroup.max.descendants",
+    "cpu.max",
+    "memory.high",
+    "memory.low",
+    "memory.max",
+    "memory.min",
+    "memory.swap.high",
+    "memory.swap.max",
+    "memory.zswap.max",
+    "pids.max",
+    0
+};
+
+static bool cgroup_limit_file(const char* path) {
+    const char* slash = strrchr(path, '/');
+    const char* name = slash ? slash + 1 : path;
+    for (const char** item = cgroup_limit_files; *item; ++item) {
+        if (!strcmp(name, *item)) {
+            return true;
+        }
+    }
+
+    // hugetlb.<size>.max and hugetlb.<size>.rsvd.max
+    const size_t len = strlen(name);
+    return !strncmp(name, "hugetlb.", 8) && len > 12 && !strcmp(name + len - 4, ".max");
+}
+
+// Values in cgroup files are numbers, "max" (unless max_is_value is false)
+// or the value part of "key=value" tokens. Everything else (flat keys,
+// device numbers) is a key.
+static bool cgroup_token_value(const char* token, size_t len, bool max_is_value,
+                               double* value) {
+    const char* eq = (const char*)memchr(token, '=', len);
+    if (eq) {
+        len -= eq + 1 - token;
+        token = eq + 1;
+    }
+
+    if (len == 3 && !strncmp(token, "max", 3) && (max_is_value || eq)) {
+        *value = INFINITY;
+        return true;
+    }
+
+    // strtod() would also accept words such as "inf" or "nan"
+    if (len == 0 || !(isdigit((unsigned char)token[0]) || token[0] == '-' || token[0] == '.')) {
+        return false;
+    }
+
+    char* end;
+    std::string str(token, len);
+    *value = strtod(str.c_str(), &end);
+    return *end == '\0';
+}
+
+// calls fn(token, len, line_start) for every whitespace separated token
+template <typename F>
+static void cgroup_tokens(const std::string& text, F fn) {
+    const char* p = text.c_str();
+    const char* end = p + text.size();
+    bool line_start = true;
+    while (p < end) {
+        if (*p == '\n') {
+            line_start = true;
+            ++p;
+        } else if (*p == ' ' || *p == '\t') {
+            ++p;
+        } else {
+            const char* start = p;
+            while (p < end && *p != ' ' && *p != '\t' && *p != '\n') {
+                ++p;
+            }
+            fn(start, p - start, line_start);
+            line_start = false;
+        }
+    }
+}
+
+#ifndef CGROUP2_SUPER_MAGIC
+#  define CGROUP2_SUPER_MAGIC 0x63677270
+#endif
+
+static bool cgroup2_mount(const std::string& path) {
+    struct statfs fs;
+    return !statfs(path.c_str(), &fs) && fs.f_type == CGROUP2_SUPER_MAGIC;
+}
+
+// Return the cgroup v2 directory of the process. With verify, root must be
+// a cgroup2 mount; hybrid hosts mount the v1 controllers on a tmpfs at the
+// usual root and the unified hierarchy at <root>/unified.
+NAN_METHOD(node_cgroup_path) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 3) {
+        return Nan::ThrowError("cgroup_path: takes exactly 3 arguments");
+    }
+
+    if (!info[0]->IsString() || !info[1]->IsString()) {
+        return Nan::ThrowTypeError("cgroup_path: first and second argument must be strings");
+    }
+
+    Nan::Utf8String root_arg(info[0]);
+    Nan::Utf8String proc_cgroup(info[1]);
+    std::string root(*root_arg);
+
+    if (Nan::To<bool>(info[2]).FromJust() && !cgroup2_mount(root)) {
+        root += "/unified";
+        if (!cgroup2_mount(root)) {
+            return Nan::ThrowError("cgroup_path: no cgroup2 filesystem mounted");
+        }
+    }
+
+    int fd = open(*proc_cgroup, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return Nan::ThrowError(Nan::ErrnoException(errno, "cgroup_path", ""));
+    }
+
+    std::string text;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0 || (n < 0 && errno == EINTR)) {
+        if (n > 0) {
+            text.append(buf, n);
+        }
+    }
+    int read_errno = errno;
+    close(fd);
+    if (n < 0) {
+        return Nan::ThrowError(Nan::ErrnoException(read_errno, "cgroup_path", ""));
+    }
+
+    // the unified (v2) hierarchy is listed as "0::/path"
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string::npos) {
+            eol = text.size();
+        }
+        if (!text.compare(pos, 3, "0::")) {
+            std::string path(root);
+            std::string rel = text.substr(pos + 3, eol - pos - 3);
+            if (rel != "/") {
+                path += rel;
+            }
+            info.GetReturnValue().Set(Nan::New<String>(path).ToLocalChecked());
+            return;
+        }
+        pos = eol + 1;
+    }
+
+    return Nan::ThrowError("cgroup_path: process is not in a cgroup v2 hierarchy");
+}
+
+// read all values of a cgroup file into a Float64Array in file order,
+// returns the number of values in the file (may exceed the array length)
+NAN_METHOD(node_cgroup_read) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 2) {
+        return Nan::ThrowError("cgroup_read: takes exactly 2 arguments");
+    }
+
+    if (!info[0]->IsString()) {
+        return Nan::ThrowTypeError("cgroup_read: first argument must be a string");
+    }
+
+    if (!info[1]->IsFloat64Array()) {
+        return Nan::ThrowTypeError("cgroup_read: second argument must be a Float64Array");
+    }
+
+    Nan::Utf8String path(info[0]);
+    std::string text;
+    if (!cgroup_pread(*path, &text)) {
+        return Nan::ThrowError(Nan::ErrnoException(errno, "cgroup_read", "", *path));
+    }
+
+    Nan::TypedArrayContents<double> out(info[1]);
+    double* values = *out;
+    const size_t length = out.length();
+    const bool limit_file = cgroup_limit_file(*path);
+    uint32_t count = 0;
+    cgroup_tokens(text, [&](const char* token, size_t len, bool line_start) {
+        double value;
+        if (cgroup_token_value(token, len, limit_file || !line_start, &value)) {
+            if (count < length) {
+                values[count] = value;
+            }
+            ++count;
+        }
+    });
+
+    info.GetReturnValue().Set(Nan::New<Integer>(count));
+}
+
+struct cgroup_value_t {
+    std::string name; // key of a "key=value" token, empty otherwise
+    double value;
+};
+
+// Read and decode a cgroup file with a single read into
+// - a number or an array of numbers for files without keys (memory.max,
+//   cpu.max)
+// - { key: number } for flat keyed files (memory.stat, memory.events)
+// - { key: { name: number } } for nested keyed files (io.stat, *.pressure),
+//   values without a name are stored under their position in the line
+// - the text of the file, without the trailing newline, if a line has no
+//   values (cpuset.cpus, cgroup.controllers, cgroup.type)
+NAN_METHOD(node_cgroup_stat) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 1) {
+        return Nan::ThrowError("cgroup_stat: takes exactly 1 argument");
+    }
+
+    if (!info[0]->IsString()) {
+        return Nan::ThrowTypeError("cgroup_stat: argument must be a string");
+    }
+
+    Nan::Utf8String path(info[0]);
+    std::string text;
+    if (!cgroup_pread(*path, &text)) {
+        return Nan::ThrowError(Nan::ErrnoException(errno, "cgroup_stat", "", *path));
+    }
+
+    Local<Object> keyed = Nan::New<Object>();
+    Local<Array> flat = Nan::New<Array>();
+    uint32_t flat_count = 0, line_count = 0;
+    double flat_first = 0;
+    bool is_keyed = false, is_text = false;
+
+    // the line being parsed
+    std::string key;
+    std::vector<cgroup_value_t> values;
+
+    auto flush_line = [&]() {
+        if (values.empty()) {
+            is_text = true;
+        } else if (key.empty()) {
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (!flat_count) {
+                    flat_first = values[i].value;
+                }
+                Nan::Set(flat, flat_count++, Nan::New<Number>(values[i].value));
+            }
+        } else if (values.size() == 1 && values[0].name.empty()) {
+            Nan::Set(keyed, Nan::New<String>(key).ToLocalChecked(),
+                     Nan::New<Number>(values[0].value));
+        } else {
+            Local<Object> entry = Nan::New<Object>();
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (values[i].name.empty()) {
+                    Nan::Set(entry, (uint32_t)i, Nan::New<Number>(values[i].value));
+                } else {
+                    Nan::Set(entry, Nan::New<String>(values[i].name).ToLocalChecked(),
+                             Nan::New<Number>(values[i].value));
+                }
+            }
+            Nan::Set(keyed, Nan::New<String>(key).ToLocalChecked(), entry);
+        }
+        is_keyed = is_keyed || !key.empty();
+        key.clear();
+        values.clear();
+    };
+
+    const bool limit_file = cgroup_limit_file(*path);
+    cgroup_tokens(text, [&](const char* token, size_t len, bool line_start) {
+        if (line_start && line_count++) {
+            flush_line();
+        }
+
+        cgroup_value_t value;
+        if (!cgroup_token_value(token, len, limit_file || !line_start, &value.value)) {
+            if (line_start) {
+                // a line prefix such as a flat key or a device number
+                key.assign(token, len);
+            }
+            return;
+        }
+
+        const char* eq = (const char*)memchr(token, '=', len);
+        if (eq) {
+            value.name.assign(token, eq - token);
+        }
+        values.push_back(value);
+    });
+    if (line_count) {
+        flush_line();
+    }
+
+    if (is_text) {
+        size_t end = text.find_last_not_of(" \t\n");
+        text.erase(end == std::string::npos ? 0 : end + 1);
+        info.GetReturnValue().Set(Nan::New<String>(text).ToLocalChecked());
+    } else if (is_keyed || !line_count) {
+        info.GetReturnValue().Set(keyed);
+    } else if (flat_count == 1) {
+        info.GetReturnValue().Set(Nan::New<Number>(flat_first));
+    } else {
+        info.GetReturnValue().Set(flat);
+    }
+}
+
+NAN_METHOD(node_cgroup_write) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 2) {
+        return Nan::ThrowError("cgroup_write: takes exactly 2 arguments");
+    }
+
+    if (!info[0]->IsString() || !info[1]->IsString()) {
+        return Nan::ThrowTypeError("cgroup_write: arguments must be strings");
+    }
+
+    Nan::Utf8String path(info[0]);
+    Nan::Utf8String value(info[1]);
+
+    // writes are rare, so the fd is not cached
+    int fd = open(*path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd < 0) {
+        return Nan::ThrowError(Nan::ErrnoException(errno, "cgroup_write", "", *path));
+    }
+
+    ssize_t n;
+    do {
+        n = write(fd, *value, value.length());
+    } while (n < 0 && errno == EINTR);
+    int write_errno = errno;
+    close(fd);
+
+    if (n < 0) {
+        return Nan::ThrowError(Nan::ErrnoException(write_errno, "cgroup_write", "", *path));
+    }
+
+    info.GetReturnValue().Set(Nan::Undefined());
+}
+
+NAN_METHOD(node_cgroup_close) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 0) {
+        return Nan::ThrowError("cgroup_close: takes no arguments");
+    }
+
+    for (size_t i = 0; i < cgroup_fd_count; ++i) {
+        close(cgroup_fds[i].fd);
+        cgroup_fds[i].path.clear();
+    }
+    cgroup_fd_count = 0;
+
+    info.GetReturnValue().Set(Nan::Undefined());
+}
+
+// Pressure stall information (PSI) from /proc/pressure/* or the *.pressure
+// files of a cgroup:
+//
+//   some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+//   full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+//
+// is parsed into PSI_VALUES doubles: some avg10, avg60, avg300, total and the
+// same for full. Values of missing lines (e.g. "full" of cpu on older
+// kernels) are NaN.
+static const size_t PSI_VALUES = 8;
+
+static void psi_parse(const std::string& text, double* out) {
+    static const char* fields[] = { "avg10=", "avg60=", "avg300=", "total=" };
+    for (size_t i = 0; i < PSI_VALUES; ++i) {
+        out[i] = NAN;
+    }
+
+    int base = -1;
+    cgroup_tokens(text, [&](const char* token, size_t len, bool line_start) {
+        if (line_start) {
+            if (len == 4 && !strncmp(token, "some", 4)) {
+                base = 0;
+            } else if (len == 4 && !strncmp(token, "full", 4)) {
+                base = 4;
+            } else {
+                base = -1;
+            }
+            return;
+        }
+        if (base < 0) {
+            return;
+        }
+        for (size_t i = 0; i < 4; ++i) {
+            const size_t flen = strlen(fields[i]);
+            double value;
+            if (len > flen && !strncmp(token, fields[i], flen)
+                && cgroup_token_value(token, len, true, &value)) {
+                out[base + i] = value;
+            }
+        }
+    });
+}
+
+NAN_METHOD(node_psi_read) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 2) {
+        return Nan::ThrowError("psi_read: takes exactly 2 arguments");
+    }
+
+    if (!info[0]->IsString()) {
+        return Nan::ThrowTypeError("psi_read: first argument must be a string");
+    }
+
+    if (!info[1]->IsFloat64Array()) {
+        return Nan::ThrowTypeError("psi_read: second argument must be a Float64Array");
+    }
+
+    Nan::TypedArrayContents<double> out(info[1]);
+    if (out.length() < PSI_VALUES) {
+        return Nan::ThrowRangeError("psi_read: array is too small");
+    }
+
+    Nan::Utf8String path(info[0]);
+    std::string text;
+    if (!cgroup_pread(*path, &text)) {
+        return Nan::ThrowError(Nan::ErrnoException(errno, "psi_read", "", *path));
+    }
+
+    psi_parse(text, *out);
+
+    info.GetReturnValue().Set(Nan::Undefined());
+}
+
+// PSI triggers need POLLPRI, which libuv supports as UV_PRIORITIZED since 1.11
+#if UV_VERSION_MAJOR > 1 || (UV_VERSION_MAJOR == 1 && UV_VERSION_MINOR >= 11)
+#  define HAVE_PSI_WATCH
+
+// A PSI trigger is bound to the fd it was written to and is removed when the
+// fd is closed, so every watch keeps its own fd and poll handle.
+struct psi_watch_t {
+    uv_poll_t poll;
+    int id;
+    int fd;
+    Nan::Callback callback;
+    Nan::AsyncResource* resource;
+    psi_watch_t* next;
+};
+
+static psi_watch_t* psi_watches = NULL;
+static int psi_next_id = 1;
+
+static psi_watch_t* psi_find(int id) {
+    for (psi_watch_t* watch = psi_watches; watch; watch = watch->next) {
+        if (watch->id == id) {
+            return watch;
+        }
+    }
+    return NULL;
+}
+
+static void psi_poll_cb(uv_poll_t* handle, int status, int events) {
+    psi_watch_t* watch = static_cast<psi_watch_t*>(handle->data);
+    Nan::HandleScope scope;
+
+    if (status < 0) {
+        // e.g. the cgroup was removed, the trigger is gone for good
+        uv_poll_stop(handle);
+        Local<Value> argv[] = { Nan::ErrnoException(-status, "psi_watch", "") };
+        watch->callback.Call(1, argv, watch->resource);
+        return;
+    }
+
+    if (!(events & UV_PRIORITIZED)) {
+        return;
+    }
+
+    std::string text;
+    if (!pread_all(watch->fd, &text)) {
+        Local<Value> argv[] = { Nan::ErrnoException(errno, "psi_watch", "") };
+        watch->callback.Call(1, argv, watch->resource);
+        return;
+    }
+
+    Local<v8::Float64Array> values = v8::Float64Array::New(
+        v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), PSI_VALUES * sizeof(double)),
+        0, PSI_VALUES);
+    Nan::TypedArrayContents<double> out(values);
+    psi_parse(text, *out);
+
+    Local<Value> argv[] = { Nan::Null(), values };
+    watch->callback.Call(2, argv, watch->resource);
+}
+
+static void psi_close_cb(uv_handle_t* handle) {
+    psi_watch_t* watch = static_cast<psi_watch_t*>(handle->data);
+    close(watch->fd);
+    delete watch->resource;
+    delete watch;
+}
+
+// register a trigger such as "some 150000 1000000" on a pressure file and
+// call callback(err, values) every time it fires, returns the watch id
+NAN_METHOD(node_psi_watch) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 3) {
+        return Nan::ThrowError("psi_watch: takes exactly 3 arguments");
+    }
+
+    if (!info[0]->IsString() || !info[1]->IsString()) {
+        return Nan::ThrowTypeError("psi_watch: first and second argument must be strings");
+    }
+
+    if (!info[2]->IsFunction()) {
+        return Nan::ThrowTypeError("psi_watch: third argument must be a function");
+    }
+
+    Nan::Utf8String path(info[0]);
+    Nan::Utf8String trigger(info[1]);
+
+    int fd = open(*path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return Nan::ThrowError(Nan::ErrnoException(errno, "psi_watch", "", *path));
+    }
+
+    // the kernel expects the terminating NUL to be written as well
+    ssize_t n;
+    do {
+        n = write(fd, *trigger, trigger.length() + 1);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        int write_errno = errno;
+        close(fd);
+        return Nan::ThrowError(Nan::ErrnoException(write_errno, "psi_watch", "", *path));
+    }
+
+    psi_watch_t* watch = new psi_watch_t;
+    int rc = uv_poll_init(Nan::GetCurrentEventLoop(), &watch->poll, fd);
+    if (rc == 0) {
+        watch->poll.data = watch;
+        rc = uv_poll_start(&watch->poll, UV_PRIORITIZED, psi_poll_cb);
+        if (rc != 0) {
+            // the handle is initialized, so it has to go through uv_close
+            watch->fd = fd;
+            watch->resource = NULL;
+            uv_close(reinterpret_cast<uv_handle_t*>(&watch->poll), psi_close_cb);
+            return Nan::ThrowError(Nan::ErrnoException(-rc, "psi_watch", "", *path));
+        }
+    } else {
+        delete watch;
+        close(fd);
+        return Nan::ThrowError(Nan::ErrnoException(-rc, "psi_watch", "", *path));
+    }
+
+    watch->id = psi_next_id++;
+    watch->fd = fd;
+    watch->callback.Reset(info[2].As<v8::Function>());
+    watch->resource = new Nan::AsyncResource("posix:psi_watch");
+    watch->next = psi_watches;
+    psi_watches = watch;
+
+    info.GetReturnValue().Set(Nan::New<Integer>(watch->id));
+}
+
+NAN_METHOD(node_psi_unwatch) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 1) {
+        return Nan::ThrowError("psi_unwatch: takes exactly 1 argument");
+    }
+
+    if (!info[0]->IsNumber()) {
+        return Nan::ThrowTypeError("psi_unwatch: argument must be an integer");
+    }
+
+    const int id = Nan::To<int32_t>(info[0]).FromJust();
+    psi_watch_t** link = &psi_watches;
+    while (*link && (*link)->id != id) {
+        link = &(*link)->next;
+    }
+
+    if (!*link) {
+        return Nan::ThrowError("psi_unwatch: unknown watch id");
+    }
+
+    psi_watch_t* watch = *link;
+    *link = watch->next;
+    uv_poll_stop(&watch->poll);
+    uv_close(reinterpret_cast<uv_handle_t*>(&watch->poll), psi_close_cb);
+
+    info.GetReturnValue().Set(Nan::Undefined());
+}
+
+// like timers, a referenced watch keeps the event loop alive
+NAN_METHOD(node_psi_ref) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 2) {
+        return Nan::ThrowError("psi_ref: takes exactly 2 arguments");
+    }
+
+    if (!info[0]->IsNumber()) {
+        return Nan::ThrowTypeError("psi_ref: first argument must be an integer");
+    }
+
+    psi_watch_t* watch = psi_find(Nan::To<int32_t>(info[0]).FromJust());
+    if (!watch) {
+        return Nan::ThrowError("psi_ref: unknown watch id");
+    }
+
+    if (Nan::To<bool>(info[1]).FromJust()) {
+        uv_ref(reinterpret_cast<uv_handle_t*>(&watch->poll));
+    } else {
+        uv_unref(reinterpret_cast<uv_handle_t*>(&watch->poll));
+    }
+
+    info.GetReturnValue().Set(Nan::Undefined());
+}
+#endif // UV_VERSION
 #endif // __linux__
 
+// Opt-in call instrumentation. Every exported binding goes through
+// instrumented<>, which costs one relaxed atomic load while stats are
+// disabled. When enabled, each call updates lock-free per-binding counters:
+// call count, error count, errno breakdown and a log-linear (HDR-style)
+// latency histogram in nanoseconds.
+static const size_t MAX_BINDINGS = 64;
+static const size_t STATS_ERRNO_BUCKETS = 160; // slot 0: error without errno
+static const size_t STATS_HIST_SUB_BITS = 2; // 4 sub-buckets per power of 2
+static const size_t STATS_HIST_OCTAVES = 40; // up to ~2^40 ns (~18 minutes)
+static const size_t STATS_HIST_BUCKETS = STATS_HIST_OCTAVES << STATS_HIST_SUB_BITS;
+
+// snapshot record layout, one record per binding in registration order
+enum {
+    STATS_CALLS = 0,
+    STATS_ERRORS,
+    STATS_TOTAL_NS,
+    STATS_MAX_NS,
+    STATS_ERRNO_OFFSET,
+    STATS_HIST_OFFSET = STATS_ERRNO_OFFSET + STATS_ERRNO_BUCKETS,
+    STATS_RECORD_SIZE = STATS_HIST_OFFSET + STATS_HIST_BUCKETS
+};
+
+struct binding_stats_t {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> errors;
+    std::atomic<uint64_t> total_ns;
+    std::atomic<uint64_t> max_ns;
+    std::atomic<uint64_t> errnos[STATS_ERRNO_BUCKETS];
+    std::atomic<uint64_t> latency[STATS_HIST_BUCKETS];
+};
+
+static std::atomic<bool> stats_enabled(false);
+static binding_stats_t binding_stats[MAX_BINDINGS];
+static const char* binding_names[MAX_BINDINGS];
+static size_t binding_count = 0;
+
+// returns the stats slot of a binding, registering it on first use; only
+// called from init(), which runs once as the module is not context-aware
+static int register_binding(const char* name) {
+    for (size_t i = 0; i < binding_count; ++i) {
+        if (!strcmp(binding_names[i], name)) {
+            return i;
+        }
+    }
+
+    if (binding_count == MAX_BINDINGS) {
+        return -1; // not tracked
+    }
+
+    binding_names[binding_count] = name;
+    return binding_count++;
+}
+
+static size_t latency_bucket(uint64_t ns) {
+    const uint64_t sub_count = 1 << STATS_HIST_SUB_BITS;
+    if (ns < sub_count) {
+        return ns;
+    }
+
+    const size_t msb = 63 - __builtin_clzll(ns);
+    const size_t bucket = ((msb - STATS_HIST_SUB_BITS + 1) << STATS_HIST_SUB_BITS)
+        + ((ns >> (msb - STATS_HIST_SUB_BITS)) & (sub_count - 1));
+    return bucket < STATS_HIST_BUCKETS ? bucket : STATS_HIST_BUCKETS - 1;
+}
+
+// inclusive lower bound of a latency bucket in nanoseconds
+static uint64_t latency_bucket_floor(size_t bucket) {
+    const uint64_t sub_count = 1 << STATS_HIST_SUB_BITS;
+    if (bucket < sub_count) {
+        return bucket;
+    }
+
+    const size_t msb = (bucket >> STATS_HIST_SUB_BITS) + STATS_HIST_SUB_BITS - 1;
+    return (sub_count | (bucket & (sub_count - 1))) << (msb - STATS_HIST_SUB_BITS);
+}
+
+static void stats_record(binding_stats_t* stats, uint64_t ns, bool failed, int err) {
+    stats->calls.fetch_add(1, std::memory_order_relaxed);
+    stats->total_ns.fetch_add(ns, std::memory_order_relaxed);
+    stats->latency[latency_bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = stats->max_ns.load(std::memory_order_relaxed);
+    while (ns > max && !stats->max_ns.compare_exchange_weak(max, ns,
+                                                            std::memory_order_relaxed)) {
+    }
+
+    if (failed) {
+        const size_t slot = (err > 0 && (size_t)err < STATS_ERRNO_BUCKETS) ? err : 0;
+        stats->errors.fetch_add(1, std::memory_order_relaxed);
+        stats->errnos[slot].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// errno of an exception from Nan::ErrnoException(), 0 for other errors;
+// the global errno may have been changed by anything the binding called
+static int exception_errno(Local<Value> exception) {
+    if (!exception->IsObject()) {
+        return 0;
+    }
+
+    Nan::MaybeLocal<Value> value = Nan::Get(Nan::To<Object>(exception).ToLocalChecked(),
+                                            Nan::New<String>("errno").ToLocalChecked());
+    if (value.IsEmpty() || !value.ToLocalChecked()->IsNumber()) {
+        return 0;
+    }
+
+    // libuv style errors are negative
+    const int err = Nan::To<int32_t>(value.ToLocalChecked()).FromJust();
+    return err < 0 ? -err : err;
+}
+
+template <Nan::FunctionCallback method>
+static NAN_METHOD(instrumented) {
+    if (!stats_enabled.load(std::memory_order_relaxed)) {
+        return method(info);
+    }
+
+    const int slot = info.Data().As<v8::Int32>()->Value();
+    if (slot < 0) {
+        return method(info);
+    }
+
+    // errors are reported to JS as exceptions, catch and re-throw them to
+    // see which calls failed and with which errno
+    Nan::TryCatch try_catch;
+    const uint64_t start = uv_hrtime();
+    method(info);
+    const uint64_t elapsed = uv_hrtime() - start;
+    const bool failed = try_catch.HasCaught();
+
+    stats_record(&binding_stats[slot], elapsed, failed,
+                 failed ? exception_errno(try_catch.Exception()) : 0);
+
+    if (failed) {
+        try_catch.ReThrow();
+    }
+}
+
+NAN_METHOD(node_stats_enable) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 1) {
+        return Nan::ThrowError("stats_enable: takes exactly 1 argument");
+    }
+
+    const bool previous = stats_enabled.exchange(Nan::To<bool>(info[0]).FromJust());
+
+    info.GetReturnValue().Set(Nan::New(previous));
+}
+
+NAN_METHOD(node_stats_reset) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 0) {
+        return Nan::ThrowError("stats_reset: takes no arguments");
+    }
+
+    for (size_t i = 0; i < MAX_BINDINGS; ++i) {
+        binding_stats_t* stats = &binding_stats[i];
+        stats->calls.store(0, std::memory_order_relaxed);
+        stats->errors.store(0, std::memory_order_relaxed);
+        stats->total_ns.store(0, std::memory_order_relaxed);
+        stats->max_ns.store(0, std::memory_order_relaxed);
+        for (size_t j = 0; j < STATS_ERRNO_BUCKETS; ++j) {
+            stats->errnos[j].store(0, std::memory_order_relaxed);
+        }
+        for (size_t j = 0; j < STATS_HIST_BUCKETS; ++j) {
+            stats->latency[j].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    info.GetReturnValue().Set(Nan::Undefined());
+}
+
+NAN_METHOD(node_stats_layout) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 0) {
+        return Nan::ThrowError("stats_layout: takes no arguments");
+    }
+
+    Local<Array> names = Nan::New<Array>();
+    for (size_t i = 0; i < binding_count; ++i) {
+        Nan::Set(names, i, Nan::New<String>(binding_names[i]).ToLocalChecked());
+    }
+
+    Local<Array> floors = Nan::New<Array>();
+    for (size_t i = 0; i < STATS_HIST_BUCKETS; ++i) {
+        Nan::Set(floors, i, Nan::New<Number>((double)latency_bucket_floor(i)));
+    }
+
+    Local<Object> obj = Nan::New<Object>();
+    Nan::Set(obj, Nan::New<String>("bindings").ToLocalChecked(), names);
+    Nan::Set(obj, Nan::New<String>("record_size").ToLocalChecked(), Nan::New<Integer>(STATS_RECORD_SIZE));
+    Nan::Set(obj, Nan::New<String>("calls").ToLocalChecked(), Nan::New<Integer>(STATS_CALLS));
+    Nan::Set(obj, Nan::New<String>("errors").ToLocalChecked(), Nan::New<Integer>(STATS_ERRORS));
+    Nan::Set(obj, Nan::New<String>("total_ns").ToLocalChecked(), Nan::New<Integer>(STATS_TOTAL_NS));
+    Nan::Set(obj, Nan::New<String>("max_ns").ToLocalChecked(), Nan::New<Integer>(STATS_MAX_NS));
+    Nan::Set(obj, Nan::New<String>("errno_offset").ToLocalChecked(), Nan::New<Integer>(STATS_ERRNO_OFFSET));
+    Nan::Set(obj, Nan::New<String>("errno_count").ToLocalChecked(), Nan::New<Integer>((uint32_t)STATS_ERRNO_BUCKETS));
+    Nan::Set(obj, Nan::New<String>("latency_offset").ToLocalChecked(), Nan::New<Integer>(STATS_HIST_OFFSET));
+    Nan::Set(obj, Nan::New<String>("latency_count").ToLocalChecked(), Nan::New<Integer>((uint32_t)STATS_HIST_BUCKETS));
+    Nan::Set(obj, Nan::New<String>("latency_floor_ns").ToLocalChecked(), floors);
+
+    info.GetReturnValue().Set(obj);
+}
+
+// copy the counters of all registered bindings into a Float64Array of at
+// least binding_count * STATS_RECORD_SIZE elements
+NAN_METHOD(node_stats_snapshot) {
+    Nan::HandleScope scope;
+
+    if (info.Length() != 1) {
+        return Nan::ThrowError("stats_snapshot: takes exactly 1 argument");
+    }
+
+    if (!info[0]->IsFloat64Array()) {
+        return Nan::ThrowTypeError("stats_snapshot: argument must be a Float64Array");
+    }
+
+    Nan::TypedArrayContents<double> out(info[0]);
+    if (out.length() < binding_count * STATS_RECORD_SIZE) {
+        return Nan::ThrowRangeError("stats_snapshot: array is too small");
+    }
+
+    for (size_t i = 0; i < binding_count; ++i) {
+        const binding_stats_t* stats = &binding_stats[i];
+        double* record = *out + i * STATS_RECORD_SIZE;
+        record[STATS_CALLS] = stats->calls.load(std::memory_order_relaxed);
+        record[STATS_ERRORS] = stats->errors.load(std::memory_order_relaxed);
+        record[STATS_TOTAL_NS] = stats->total_ns.load(std::memory_order_relaxed);
+        record[STATS_MAX_NS] = stats->max_ns.load(std::memory_order_relaxed);
+        for (size_t j = 0; j < STATS_ERRNO_BUCKETS; ++j) {
+            record[STATS_ERRNO_OFFSET + j] = stats->errnos[j].load(std::memory_order_relaxed);
+        }
+        for (size_t j = 0; j < STATS_HIST_BUCKETS; ++j) {
+            record[STATS_HIST_OFFSET + j] = stats->latency[j].load(std::memory_order_relaxed);
+        }
+    }
+
+    info.GetReturnValue().Set(Nan::New<Integer>((uint32_t)binding_count));
+}
+
 #define EXPORT(name, symbol) Nan::Set(exports, \
+  Nan::New<String>(name).ToLocalChecked(), \
+  Nan::GetFunction(Nan::New<FunctionTemplate>(instrumented<symbol>, \
+    Nan::New<Integer>(register_binding(name)))).ToLocalChecked() \
+)
+
+#define EXPORT_UNINSTRUMENTED(name, symbol) Nan::Set(exports, \
   Nan::New<String>(name).ToLocalChecked(), \
   Nan::GetFunction(Nan::New<FunctionTemplate>(symbol)).ToLocalChecked()    \
 )
@@ -703,7 +1673,23 @@ void init(Local<Object> exports) {
       EXPORT("swapon", node_swapon);
       EXPORT("swapoff", node_swapoff);
       EXPORT("update_swap_constants", node_update_swap_constants);
+      EXPORT("cgroup_path", node_cgroup_path);
+      EXPORT("cgroup_read", node_cgroup_read);
+      EXPORT("cgroup_stat", node_cgroup_stat);
+      EXPORT("cgroup_write", node_cgroup_write);
+      EXPORT("cgroup_close", node_cgroup_close);
+      EXPORT("psi_read", node_psi_read);
+    #ifdef HAVE_PSI_WATCH
+      EXPORT("psi_watch", node_psi_watch);
+      EXPORT("psi_unwatch", node_psi_unwatch);
+      EXPORT("psi_ref", node_psi_ref);
     #endif
+    #endif
+
+    EXPORT_UNINSTRUMENTED("stats_enable", node_stats_enable);
+    EXPORT_UNINSTRUMENTED("stats_reset", node_stats_reset);
+    EXPORT_UNINSTRUMENTED("stats_layout", node_stats_layout);
+    EXPORT_UNINSTRUMENTED("stats_snapshot", node_stats_snapshot);
 }
 
 NODE_MODULE(posix, init);
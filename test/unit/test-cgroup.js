@@ -0,0 +1,133 @@
+var assert = require('assert');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var posix = require('../../lib/posix');
+
+if (!posix.cgroup_path) {
+    return; // Linux only
+}
+
+// fake cgroupfs tree
+var root = fs.mkdtempSync(path.join(os.tmpdir(), 'test-node-posix-cgroup-'));
+var proc_cgroup = path.join(root, 'cgroup');
+var dir = path.join(root, 'system.slice', 'app.service');
+fs.mkdirSync(path.join(root, 'system.slice'));
+fs.mkdirSync(dir);
+fs.writeFileSync(proc_cgroup, '1:name=systemd:/\n0::/system.slice/app.service\n');
+fs.writeFileSync(path.join(dir, 'memory.current'), '12345678\n');
+fs.writeFileSync(path.join(dir, 'memory.max'), 'max\n');
+fs.writeFileSync(path.join(dir, 'memory.high'), 'max\n');
+fs.writeFileSync(path.join(dir, 'cpu.max'), 'max 100000\n');
+fs.writeFileSync(path.join(dir, 'memory.stat'), 'anon 4096\nfile 8192\n');
+fs.writeFileSync(path.join(dir, 'cpu.stat'),
+                 'usage_usec 100\nuser_usec 60\nsystem_usec 40\n');
+fs.writeFileSync(path.join(dir, 'memory.events'),
+                 'low 0\nhigh 3\nmax 5\noom 1\noom_kill 1\n');
+fs.writeFileSync(path.join(dir, 'pids.events'), 'max 0\n');
+fs.writeFileSync(path.join(dir, 'cgroup.max.depth'), 'max\n');
+fs.writeFileSync(path.join(dir, 'cpuset.cpus'), '0-3\n');
+fs.writeFileSync(path.join(dir, 'cgroup.controllers'), 'cpu io memory pids\n');
+fs.writeFileSync(path.join(dir, 'cgroup.max.descendants'), '100\n');
+fs.writeFileSync(path.join(dir, 'io.stat'),
+                 '8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0\n');
+
+assert.equal(posix.cgroup_path(root, proc_cgroup), dir);
+
+// the default root is a real cgroup2 mount, also on hybrid hosts
+var self_dir = null;
+try {
+    self_dir = posix.cgroup_path();
+} catch (err) {
+    assert.ok(/no cgroup2 filesystem|not in a cgroup v2 hierarchy/.test(err.message),
+              err.message);
+}
+if (self_dir) {
+    assert.ok(fs.existsSync(path.join(self_dir, 'cgroup.procs')));
+}
+
+assert.throws(function () {
+    posix.cgroup_path(root, path.join(root, 'nonexistent'));
+}, /ENOENT/);
+
+fs.writeFileSync(path.join(root, 'cgroup-v1'), '1:memory:/\n');
+assert.throws(function () {
+    posix.cgroup_path(root, path.join(root, 'cgroup-v1'));
+}, /not in a cgroup v2 hierarchy/);
+
+var values = posix.cgroup_read('memory.current', dir);
+assert.ok(values instanceof Float64Array);
+assert.deepEqual(Array.prototype.slice.call(values), [12345678]);
+assert.deepEqual(Array.prototype.slice.call(posix.cgroup_read('cpu.max', dir)),
+                 [Infinity, 100000]);
+
+// arrays too small for the file are replaced
+var small = new Float64Array(2);
+assert.equal(posix.cgroup_read('io.stat', dir, small).length, 6);
+
+assert.equal(posix.cgroup_stat('memory.max', dir), Infinity);
+assert.deepEqual(posix.cgroup_stat('cpu.max', dir), [Infinity, 100000]);
+assert.deepEqual(posix.cgroup_stat('memory.stat', dir), {anon: 4096, file: 8192});
+assert.deepEqual(posix.cgroup_stat('cpu.stat', dir),
+                 {usage_usec: 100, user_usec: 60, system_usec: 40});
+// a leading "max" is a key outside of limit files
+assert.deepEqual(Array.prototype.slice.call(posix.cgroup_read('memory.events', dir)),
+                 [0, 3, 5, 1, 1]);
+assert.deepEqual(posix.cgroup_stat('memory.events', dir),
+                 {low: 0, high: 3, max: 5, oom: 1, oom_kill: 1});
+assert.deepEqual(posix.cgroup_stat('pids.events', dir), {max: 0});
+assert.deepEqual(posix.cgroup_read('memory.high', dir)[0], Infinity);
+assert.deepEqual(Array.prototype.slice.call(posix.cgroup_read('cgroup.max.depth', dir)),
+                 [Infinity]);
+assert.equal(posix.cgroup_stat('cgroup.max.depth', dir), Infinity);
+assert.equal(posix.cgroup_stat('cgroup.max.descendants', dir), 100);
+
+// files without values are returned as text
+assert.strictEqual(posix.cgroup_stat('cpuset.cpus', dir), '0-3');
+assert.strictEqual(posix.cgroup_stat('cgroup.controllers', dir), 'cpu io memory pids');
+posix.cgroup_write('cgroup.max.descendants', Infinity, dir);
+assert.equal(posix.cgroup_stat('cgroup.max.descendants', dir), Infinity);
+assert.deepEqual(posix.cgroup_stat('io.stat', dir),
+                 {'8:0': {rbytes: 1, wbytes: 2, rios: 3, wios: 4, dbytes: 0, dios: 0}});
+
+// cached fds see the new contents
+posix.cgroup_read('memory.high', dir);
+posix.cgroup_write('memory.high', 1 << 20, dir);
+assert.equal(posix.cgroup_stat('memory.high', dir), 1 << 20);
+posix.cgroup_write('memory.high', null, dir);
+assert.equal(posix.cgroup_stat('memory.high', dir), Infinity);
+posix.cgroup_write('cpu.max', [50000, 100000], dir);
+assert.equal(fs.readFileSync(path.join(dir, 'cpu.max'), 'utf8'), '50000 100000');
+
+// nothing is written for invalid values
+[undefined, NaN, -1, 1.5, 1e21, {}, [50000, undefined], [[1]]].forEach(function (value) {
+    assert.throws(function () {
+        posix.cgroup_write('cpu.max', value, dir);
+    }, TypeError);
+});
+assert.equal(fs.readFileSync(path.join(dir, 'cpu.max'), 'utf8'), '50000 100000');
+
+assert.throws(function () {
+    posix.cgroup_read('pids.max', dir);
+}, /ENOENT/);
+
+// a failed read drops the cached fd, so a recreated path is opened again
+var swap_current = path.join(dir, 'memory.swap.current');
+fs.mkdirSync(swap_current);
+assert.throws(function () {
+    posix.cgroup_read('memory.swap.current', dir);
+}, /EISDIR/);
+fs.rmdirSync(swap_current);
+fs.writeFileSync(swap_current, '4096\n');
+assert.equal(posix.cgroup_stat('memory.swap.current', dir), 4096);
+
+posix.cgroup_close();
+fs.readdirSync(dir).forEach(function (name) {
+    fs.unlinkSync(path.join(dir, name));
+});
+fs.rmdirSync(dir);
+fs.rmdirSync(path.join(root, 'system.slice'));
+['cgroup', 'cgroup-v1'].forEach(function (name) {
+    fs.unlinkSync(path.join(root, name));
+});
+fs.rmdirSync(root);
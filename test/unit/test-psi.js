@@ -0,0 +1,138 @@
+var assert = require('assert');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var posix = require('../../lib/posix');
+
+if (!posix.psi_read) {
+    return; // Linux only
+}
+
+assert.throws(function () {
+    posix.psi_read('foobar');
+}, /invalid pressure resource/);
+
+var file = path.join(os.tmpdir(), 'test-node-posix-psi-' + process.pid);
+fs.writeFileSync(file, 'some avg10=1.50 avg60=0.25 avg300=0.00 total=42\n');
+
+var values = posix.psi_read(file);
+assert.ok(values instanceof Float64Array);
+assert.deepEqual(Array.prototype.slice.call(values, 0, 4), [1.5, 0.25, 0, 42]);
+assert.ok(isNaN(values[4]));
+
+fs.writeFileSync(file, 'some avg10=1.50 avg60=0.25 avg300=0.00 total=42\n' +
+                       'full avg10=0.50 avg60=0.10 avg300=0.00 total=7\n');
+assert.strictEqual(posix.psi_read(file, null, values), values);
+assert.deepEqual(posix.psi_stat(file), {
+    some: { avg10: 1.5, avg60: 0.25, avg300: 0, total: 42 },
+    full: { avg10: 0.5, avg60: 0.1, avg300: 0, total: 7 }
+});
+
+// psi_read() keeps its fds in the cgroup fd cache
+posix.cgroup_close();
+fs.unlinkSync(file);
+
+if (!posix.psi_watch) {
+    return;
+}
+
+assert.throws(function () {
+    posix.psi_watch('cpu', null);
+}, /invalid pressure trigger: null/);
+
+assert.throws(function () {
+    posix.psi_watch('cpu', { stall: 'some' });
+}, /invalid pressure trigger threshold: undefined/);
+
+assert.throws(function () {
+    posix.psi_watch('cpu', { stall: 'partial', threshold: 150000, window: 1000000 });
+}, /invalid pressure trigger stall: partial/);
+
+assert.throws(function () {
+    posix.psi_watch('cpu', { threshold: 150000, window: 1.5 });
+}, /invalid pressure trigger window: 1.5/);
+
+// a trigger can be written to a regular file, but it cannot be polled; the
+// watch is cleaned up and the error reported
+fs.writeFileSync(file, '');
+assert.throws(function () {
+    posix.psi_watch(file, 'some 1 2');
+}, /EPERM/);
+fs.unlinkSync(file);
+
+if (!fs.existsSync('/proc/pressure/cpu')) {
+    return;
+}
+
+var watcher;
+try {
+    watcher = posix.psi_watch('cpu', { stall: 'some', threshold: 10000,
+                                       window: 2000000 });
+} catch (err) {
+    // creating triggers may be restricted, e.g. inside containers
+    assert.ok(/EPERM|EACCES|EINVAL|EOPNOTSUPP/.test(err.message), err.message);
+    return;
+}
+
+assert.equal(watcher.trigger, 'some 10000 2000000');
+watcher.unref().ref();
+
+// keep more tasks runnable than there are CPUs until the trigger fires
+var child_process = require('child_process');
+var busy = [], events = 0, i;
+for (i = 0; i < os.cpus().length * 2; ++i) {
+    busy.push(child_process.spawn(process.execPath,
+                                  ['-e', 'for (;;) {}'], { stdio: 'ignore' }));
+}
+
+function stop_busy() {
+    busy.forEach(function (child) { child.kill(); });
+}
+
+var timeout = setTimeout(function () {
+    stop_busy();
+    watcher.close();
+    assert.fail('no CPU pressure event within 10 seconds');
+}, 10000);
+
+watcher.on('pressure', function (values, array) {
+    ++events;
+    assert.ok(array instanceof Float64Array);
+    assert.equal(array.length, 8);
+    assert.ok(values.some.total > 0);
+    assert.equal(values.some.total, array[3]);
+    clearTimeout(timeout);
+    stop_busy();
+    watcher.close();
+    watcher.close(); // closing twice is fine
+    watch_removed_cgroup();
+});
+
+// a trigger on a removed cgroup reports an error and closes the watcher;
+// needs a writable cgroup2 hierarchy, e.g. under make test-unit-sudo
+function watch_removed_cgroup() {
+    var cgroup;
+    try {
+        cgroup = path.join(posix.cgroup_path(), 'test-node-posix-' + process.pid);
+        fs.mkdirSync(cgroup);
+    } catch (err) {
+        return;
+    }
+
+    var removed = posix.psi_watch('cpu', { threshold: 100000, window: 2000000 },
+                                  cgroup);
+    var error_timeout = setTimeout(function () {
+        removed.close();
+        assert.fail('no error event for a removed cgroup');
+    }, 5000);
+    removed.on('error', function (err) {
+        clearTimeout(error_timeout);
+        assert.ok(/ENODEV/.test(err.message), err.message);
+        removed.close(); // already closed
+    });
+    fs.rmdirSync(cgroup);
+}
+
+process.on('exit', function () {
+    assert.equal(events, 1);
+});
@@ -0,0 +1,53 @@
+var assert = require('assert');
+var posix = require('../../lib/posix');
+
+posix.reset_stats();
+assert.equal(posix.enable_stats(false), false);
+
+// nothing is recorded while disabled
+posix.getppid();
+assert.deepEqual(posix.stats(), {});
+
+assert.equal(posix.enable_stats(), false);
+posix.getppid();
+posix.getppid();
+
+assert.throws(function () {
+    posix.getrlimit('foobar');
+}, /unknown resource name/);
+
+assert.throws(function () {
+    posix.chroot('/nonexistent/path/for/node-posix');
+}, /ENOENT/);
+
+// not an errno error, even if NSS leaves errno set
+assert.throws(function () {
+    posix.getpwnam('nonexistent-user-for-node-posix');
+}, /user id does not exist/);
+
+var stats = posix.stats();
+assert.equal(stats.getppid.calls, 2);
+assert.equal(stats.getppid.errors, 0);
+assert.ok(stats.getppid.total_ns >= stats.getppid.max_ns);
+assert.ok(stats.getppid.latency instanceof Float64Array);
+assert.equal(stats.getppid.latency.length, posix.stats.latency_floor_ns.length);
+assert.equal(Array.prototype.reduce.call(stats.getppid.latency,
+                                         function (a, b) { return a + b; }, 0), 2);
+
+assert.equal(stats.getrlimit.errors, 1);
+assert.deepEqual(stats.getrlimit.errno, { other: 1 });
+assert.equal(stats.chroot.errors, 1);
+assert.deepEqual(stats.chroot.errno, { ENOENT: 1 });
+assert.deepEqual(stats.getpwnam.errno, { other: 1 });
+
+// earlier snapshots are not changed by later calls
+posix.getppid();
+var later = posix.stats();
+assert.equal(later.getppid.calls, 3);
+assert.equal(stats.getppid.calls, 2);
+assert.equal(Array.prototype.reduce.call(stats.getppid.latency,
+                                         function (a, b) { return a + b; }, 0), 2);
+
+assert.equal(posix.enable_stats(false), true);
+posix.reset_stats();
+assert.deepEqual(posix.stats(), {});